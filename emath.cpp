@@ -9,6 +9,12 @@
 
 #include "emath.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QMutex>
+
 #ifdef WIN32
 #include <stdio.h>
 #endif
@@ -32,45 +38,97 @@
 
 static bool debug_mode = false;
 
+// Snapshot of all known units and Convertions; never modified once published
+struct em_registry
+{
+	const struct emu_entry* units;
+	size_t units_size;
+	const struct em_conv* conv;
+	size_t conv_size;
+	unsigned int generation; // incremented whenever the Convertions change
+};
+
+// the built-in tables seed the registry
+static const struct em_registry EM_REGISTRY_SEED =
+{
+	EMU_TABLE_UNITS, EMU_TABLE_UNITS_SIZE,
+	EM_TABLE_CONV,   EM_TABLE_CONV_SIZE,
+	0
+};
+
+// Readers only load the current snapshot; writers serialize on the mutex,
+// publish a modified copy and never free the replaced one, since readers
+// and resolved plans may still point into it.
+static QAtomicPointer<const struct em_registry> em_registry(&EM_REGISTRY_SEED);
+static QMutex em_registry_lock;
+
+// lookup the Convertion for a pair of units in a snapshot; internal use only!
+static const struct em_conv* p_emconv_find_in(const struct em_registry* reg, int unit_src, int unit_dest)
+{
+	size_t i;
+
+	for (i=0; i<reg->conv_size; i++){
+		const struct em_conv* conv = reg->conv + i;
+		if( conv->unit_src == unit_src && conv->unit_dst == unit_dest )
+			return conv;
+	}
+	return NULL;
+}
+
+// lookup the Convertion for a pair of units; internal use only!
+static const struct em_conv* p_emconv_find(int unit_src, int unit_dest)
+{
+	return p_emconv_find_in(em_registry.loadAcquire(), unit_src, unit_dest);
+}
+
+// check that the convert method matching argc is defined; internal use only!
+static int p_emconv_check(const struct em_conv* conv)
+{
+	switch(conv->argc)
+	{
+	case 2:
+		return conv->convert2 == NULL ? EM_ERR_ARGC2NULL : EM_OK;
+	case 3:
+		return conv->convert3 == NULL ? EM_ERR_ARGC3NULL : EM_OK;
+	case 4:
+		return conv->convert4 == NULL ? EM_ERR_ARGC4NULL : EM_OK;
+	default:
+		// invalid number or arguments
+		return EM_ERR_UNKNOWNARGC;
+	}
+}
+
 // generic convert function; internal use only! 
 int p_emconv(double src, int unit_src, double* dest, int unit_dest, double impedanz, double db, uint64_t hz)
 {
-	size_t i;
+	const struct em_conv* conv;
+	int r;
 	
 	if( unit_src == unit_dest ){
 		*dest = src;
 		return EM_OK;
 	}
 	
-	for (i=0; i<EM_TABLE_CONV_SIZE; i++){
-		const struct em_conv* conv = EM_TABLE_CONV + i;
-		// forward towards desired Convertion		
-		if( conv->unit_src != unit_src || conv->unit_dst != unit_dest )
-			continue;
-		// call related convert method with the proper number of arguments
-		switch(conv->argc)
-		{
-		case 2:
-			if( conv->convert2 == NULL ) // convert2 not defined
-				return EM_ERR_ARGC2NULL;
-			conv->convert2(src, dest);
-			return EM_OK;
-		case 3:
-			if( conv->convert3 == NULL ) // convert3 not defined
-				return EM_ERR_ARGC3NULL;
-			conv->convert3(src, dest, impedanz);
-			return EM_OK;
-		case 4:
-			if( conv->convert4 == NULL ) // convert4 not defined
-				return EM_ERR_ARGC4NULL;
-			conv->convert4(src, dest, db, hz);
-			return EM_OK;	
-		default:
-			// invalid number or arguments
-			return EM_ERR_UNKNOWNARGC;
-		}
-	}	
-	return EM_ERR_UNKNOWNCONV;
+	conv = p_emconv_find(unit_src, unit_dest);
+	if( conv == NULL )
+		return EM_ERR_UNKNOWNCONV;
+	r = p_emconv_check(conv);
+	if( r != EM_OK )
+		return r;
+	// call related convert method with the proper number of arguments
+	switch(conv->argc)
+	{
+	case 2:
+		conv->convert2(src, dest);
+		break;
+	case 3:
+		conv->convert3(src, dest, impedanz);
+		break;
+	case 4:
+		conv->convert4(src, dest, db, hz);
+		break;
+	}
+	return EM_OK;
 }
 
 int emconv(double src, int unit_src, double* dest, int unit_dest, double impedanz, double db, uint64_t hz)
@@ -109,6 +167,80 @@ int emconv4(double src, int unit_src, double* dest, int unit_dest)
 	return r;
 }
 
+int emconv_plan(struct em_plan* plan, int unit_src, int unit_dest, double impedanz, double db, uint64_t hz)
+{
+	const struct em_registry* reg = em_registry.loadAcquire();
+	int r = EM_OK;
+
+	if( plan == NULL )
+		return EM_ERR_NULLPTR;
+
+	plan->generation = reg->generation;
+	plan->unit_src = unit_src;
+	plan->unit_dst = unit_dest;
+	plan->conv = NULL;
+	plan->impedanz = impedanz;
+	plan->db = db;
+	plan->hz = hz;
+
+	if( unit_src != unit_dest ){
+		plan->conv = p_emconv_find_in(reg, unit_src, unit_dest);
+		r = plan->conv == NULL ? EM_ERR_UNKNOWNCONV : p_emconv_check(plan->conv);
+	}
+	if( r != EM_OK && debug_mode ){
+		qDebug("%s: ERROR %i: %i => %i", Q_FUNC_INFO, r, unit_src, unit_dest);
+	}
+	return r;
+}
+
+int emconv_batch(const struct em_plan* plan, const double* src, double* dest, size_t count)
+{
+	const struct em_registry* reg = em_registry.loadAcquire();
+	const struct em_conv* conv;
+	size_t i;
+	int r;
+
+	if( plan == NULL || src == NULL || dest == NULL )
+		return EM_ERR_NULLPTR;
+
+	conv = plan->conv;
+	// the registry changed since the plan was resolved; follow replaced Convertions
+	if( reg->generation != plan->generation && plan->unit_src != plan->unit_dst ){
+		conv = p_emconv_find_in(reg, plan->unit_src, plan->unit_dst);
+		if( conv == NULL )
+			return EM_ERR_UNKNOWNCONV;
+		r = p_emconv_check(conv);
+		if( r != EM_OK )
+			return r;
+	}
+	if( conv == NULL ){
+		if( plan->unit_src != plan->unit_dst )
+			return EM_ERR_UNKNOWNCONV;
+		if( src != dest )
+			memmove(dest, src, count * sizeof(double));
+		return EM_OK;
+	}
+
+	// dispatch once per batch instead of once per value
+	switch(conv->argc)
+	{
+	case 2:
+		for (i=0; i<count; i++)
+			conv->convert2(src[i], dest + i);
+		return EM_OK;
+	case 3:
+		for (i=0; i<count; i++)
+			conv->convert3(src[i], dest + i, plan->impedanz);
+		return EM_OK;
+	case 4:
+		for (i=0; i<count; i++)
+			conv->convert4(src[i], dest + i, plan->db, plan->hz);
+		return EM_OK;
+	default:
+		return EM_ERR_UNKNOWNARGC;
+	}
+}
+
 void emconv_watt2dbm(double watt, double* dbm)
 {
 	*dbm = dtodb10(watt) + 30.0;
@@ -310,10 +442,99 @@ double lambda(uint64_t hz)
 
 const struct emu_entry* emu_find(int emu)
 {
-	unsigned int i;
-	for(i=0; i<EMU_TABLE_UNITS_SIZE; i++)
-		if( EMU_TABLE_UNITS[i].emu == emu )
-			return EMU_TABLE_UNITS + i;
+	const struct em_registry* reg = em_registry.loadAcquire();
+	size_t i;
+	for(i=0; i<reg->units_size; i++)
+		if( reg->units[i].emu == emu )
+			return reg->units + i;
 	return 0;
 }
 
+// publish a copy of the current snapshot extended by one unit and / or
+// Convertion; the caller must hold em_registry_lock. internal use only!
+static int p_em_registry_publish(const struct emu_entry* emu, const struct em_conv* conv, size_t conv_at)
+{
+	const struct em_registry* cur = em_registry.loadAcquire();
+	struct em_registry* reg = (struct em_registry*)malloc(sizeof(struct em_registry));
+	struct emu_entry* units = NULL;
+	struct em_conv* convs = NULL;
+
+	if( reg == NULL )
+		return EM_ERR_NOMEM;
+	*reg = *cur;
+	// only a changed Convertion table invalidates resolved plans
+	if( conv != NULL )
+		reg->generation = cur->generation + 1;
+
+	if( emu != NULL ){
+		units = (struct emu_entry*)malloc((cur->units_size + 1) * sizeof(struct emu_entry));
+		if( units == NULL ){
+			free(reg);
+			return EM_ERR_NOMEM;
+		}
+		memcpy(units, cur->units, cur->units_size * sizeof(struct emu_entry));
+		units[cur->units_size] = *emu;
+		reg->units = units;
+		reg->units_size = cur->units_size + 1;
+	}
+
+	if( conv != NULL ){
+		size_t size = conv_at < cur->conv_size ? cur->conv_size : cur->conv_size + 1;
+		convs = (struct em_conv*)malloc(size * sizeof(struct em_conv));
+		if( convs == NULL ){
+			free(units);
+			free(reg);
+			return EM_ERR_NOMEM;
+		}
+		memcpy(convs, cur->conv, cur->conv_size * sizeof(struct em_conv));
+		convs[MIN(conv_at, cur->conv_size)] = *conv;
+		reg->conv = convs;
+		reg->conv_size = size;
+	}
+
+	em_registry.storeRelease(reg);
+	return EM_OK;
+}
+
+int emu_register(const struct emu_entry* emu)
+{
+	int r;
+
+	if( emu == NULL )
+		return EM_ERR_NULLPTR;
+
+	em_registry_lock.lock();
+	r = emu_find(emu->emu) != NULL ? EM_ERR_EXISTS : p_em_registry_publish(emu, NULL, 0);
+	em_registry_lock.unlock();
+	return r;
+}
+
+int emconv_register(const struct em_conv* conv)
+{
+	const struct em_registry* cur;
+	size_t i;
+	int r;
+
+	if( conv == NULL )
+		return EM_ERR_NULLPTR;
+	if( conv->unit_src == conv->unit_dst )
+		return EM_ERR_UNKNOWNCONV;
+	r = p_emconv_check(conv);
+	if( r != EM_OK )
+		return r;
+
+	em_registry_lock.lock();
+	if( emu_find(conv->unit_src) == NULL || emu_find(conv->unit_dst) == NULL ){
+		em_registry_lock.unlock();
+		return EM_ERR_UNKNOWNUNIT;
+	}
+	// replace the Convertion for an already known pair of units
+	cur = em_registry.loadAcquire();
+	for (i=0; i<cur->conv_size; i++)
+		if( cur->conv[i].unit_src == conv->unit_src && cur->conv[i].unit_dst == conv->unit_dst )
+			break;
+	r = p_em_registry_publish(NULL, conv, i);
+	em_registry_lock.unlock();
+	return r;
+}
+
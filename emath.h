@@ -13,6 +13,7 @@
 #include "emath_global.h"
 
 #include <math.h>
+#include <stddef.h>
 #include <wchar.h>
 
 #ifdef WIN32
@@ -33,6 +34,11 @@ typedef unsigned __int64 uint64_t;
 #define EM_ERR_ARGC3NULL    -3 //! Function convert3() is not defined
 #define EM_ERR_ARGC4NULL    -4 //! Function convert4() is not defined
 #define EM_ERR_UNKNOWNARGC  -5 //! Undefined number of arguments
+#define EM_ERR_NULLPTR      -6 //! Required pointer argument is NULL
+#define EM_ERR_NOMEM        -7 //! Memory allocation failed
+#define EM_ERR_RANGE        -8 //! Index range is empty or out of bounds
+#define EM_ERR_EXISTS       -9 //! Unit of measurement is already registered
+#define EM_ERR_UNKNOWNUNIT -10 //! Unit of measurement is not registered
 
 // Base identifiers
 #define EMF_NONE  0 //! Unspezific Field
@@ -75,7 +81,8 @@ typedef unsigned __int64 uint64_t;
 
 #define EMU_TESLA  14 //! Magnetic Flux Density (B) in Tesla
 #define EMU_GAUSS  15 //! Magnetic Flux Density (B) in Gauss
-#define EMU_COUNT  16 //! Total number of supported units of measuremnt
+#define EMU_COUNT  16 //! Total number of built-in units of measuremnt
+#define EMU_USER   64 //! First identifier suggested for application defined units
 
 
 // General purpose unit Convertion; return 0 on successfull Convertion
@@ -205,6 +212,18 @@ double lambda(uint64_t frequency);
 EMATHSHARED_EXPORT
 const struct emu_entry* emu_find(int emu);
 
+//! register an additional unit of measurement; return 0 on success
+EMATHSHARED_EXPORT
+int emu_register(const struct emu_entry* emu);
+
+//! register an additional Convertion or replace the one for the same pair of units;
+//! both units must be known already. return 0 on success
+//! Every registration publishes a new copy of the registry tables and never frees
+//! the old one, so memory grows quadratically with the number of registrations;
+//! register at startup or only occasionally at runtime
+EMATHSHARED_EXPORT
+int emconv_register(const struct em_conv* conv);
+
 
 //! Structure a unit of measurement
 struct emu_entry
@@ -228,7 +247,7 @@ struct em_conv
 	void (*convert4)(double, double*, double, uint64_t);
 };
 
-//! Define the properties for all supported units of measurement
+//! Define the properties for all built-in units of measurement; see emu_register() for more
 static const struct emu_entry EMU_TABLE_UNITS[] =
 {
 	{ EMU_DBM,    EMF_ALL,             EM_DB10,   2,   L"dBm",        L""  },
@@ -251,7 +270,8 @@ static const struct emu_entry EMU_TABLE_UNITS[] =
 //! Number of elements in the unit properties table
 #define EMU_TABLE_UNITS_SIZE (sizeof(EMU_TABLE_UNITS) / sizeof(struct emu_entry))
 
-//! Define Convertion function for pairs of units ( count 2=IO, 3=IOR, 4=IODF )
+//! Define built-in Convertion function for pairs of units ( count 2=IO, 3=IOR, 4=IODF );
+//! see emconv_register() for more
 static const struct em_conv EM_TABLE_CONV[] =
 {
 	{ EMU_DBM,    EMU_WATT,   2,  &emconv_dbm2watt,      NULL,              NULL },
@@ -301,4 +321,25 @@ static const struct em_conv EM_TABLE_CONV[] =
 //! Number of elements in the unit Convertion table
 #define EM_TABLE_CONV_SIZE (sizeof(EM_TABLE_CONV) / sizeof(struct em_conv))
 
+//! Structure a resolved unit Convertion bound to its parameters
+struct em_plan
+{
+	int unit_src;
+	int unit_dst;
+	const struct em_conv* conv; //! NULL for the identity Convertion
+	unsigned int generation;    //! registry generation conv was resolved in
+	double impedanz;
+	double db;
+	uint64_t hz;
+};
+
+//! Resolve the Convertion for a pair of units once; return 0 on success
+EMATHSHARED_EXPORT
+int emconv_plan(struct em_plan* plan, int unit_src, int unit_dest, double impedanz, double db, uint64_t hz);
+//! Convert count values with a resolved plan; src and dest may be the same buffer.
+//! Plans resolved before an emconv_register() look their Convertion up again on
+//! every call; resolve them anew to avoid that lookup
+EMATHSHARED_EXPORT
+int emconv_batch(const struct em_plan* plan, const double* src, double* dest, size_t count);
+
 #endif
@@ -1,10 +1,14 @@
 INCLUDEPATH += $$PWD
 
 SOURCES += $$PWD/emath.cpp \
+			  $$PWD/emlive.cpp \
+			  $$PWD/empyr.cpp \
 			  $$PWD/emsi.cpp
 
 HEADERS += $$PWD/emath_global.h \
 				$$PWD/emath.h \
+				$$PWD/emlive.h \
+				$$PWD/empyr.h \
 				$$PWD/emsi.h
 
 DEFINES += EMATH_LIBRARY
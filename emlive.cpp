@@ -0,0 +1,260 @@
+/*
+ *  emlive.c
+ *  iemc
+ *
+ *  Live updating trace with incremental reconversion of dirty ranges.
+ *
+ */
+
+#include "emlive.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN(X,Y)  ( (X) < (Y) ? (X) : (Y) )
+#define MAX(X,Y)  ( (X) > (Y) ? (X) : (Y) )
+
+// add [first, last) to the dirty spans of a view; internal use only!
+static void p_emlive_mark(struct emlive_view* v, size_t first, size_t last)
+{
+	size_t i, best = 0, best_gap = (size_t)-1;
+
+	// absorb every span that overlaps or touches the new one
+	for (i=0; i<v->spans; ){
+		struct emlive_span* s = v->span + i;
+		if( s->first <= last && first <= s->last ){
+			first = MIN(first, s->first);
+			last = MAX(last, s->last);
+			*s = v->span[--v->spans];
+			continue;
+		}
+		i++;
+	}
+
+	if( v->spans < EMLIVE_MAX_SPANS ){
+		v->span[v->spans].first = first;
+		v->span[v->spans].last = last;
+		v->spans++;
+		return;
+	}
+
+	// out of spans; grow the one closest to the new span
+	for (i=0; i<v->spans; i++){
+		const struct emlive_span* s = v->span + i;
+		size_t gap = s->last < first ? first - s->last : s->first - last;
+		if( gap < best_gap ){
+			best_gap = gap;
+			best = i;
+		}
+	}
+	v->span[best].first = MIN(first, v->span[best].first);
+	v->span[best].last = MAX(last, v->span[best].last);
+}
+
+// fold the converted points [first, last) into the aggregates of a view; internal use only!
+static void p_emlive_fold(struct emlive_view* v, size_t first, size_t last)
+{
+	size_t i;
+
+	for (i=first; i<last; i++){
+		double x = v->values[i];
+		if( v->maxhold != NULL )
+			v->maxhold[i] = MAX(v->maxhold[i], x);
+		if( v->minhold != NULL )
+			v->minhold[i] = MIN(v->minhold[i], x);
+		if( v->average != NULL ){
+			if( v->avg_limit == 0 || v->avg_count[i] < v->avg_limit )
+				v->avg_count[i]++;
+			v->average[i] += (x - v->average[i]) / (double)v->avg_count[i];
+		}
+	}
+}
+
+static void p_emlive_free_view(struct emlive_view* v)
+{
+	free(v->values);
+	free(v->maxhold);
+	free(v->minhold);
+	free(v->average);
+	free(v->avg_count);
+	memset(v, 0, sizeof(struct emlive_view));
+}
+
+int emlive_init(struct emlive* live, size_t count, int unit, double src)
+{
+	size_t i;
+
+	if( live == NULL )
+		return EM_ERR_NULLPTR;
+
+	memset(live, 0, sizeof(struct emlive));
+	live->samples = (double*)malloc(MAX(count, 1) * sizeof(double));
+	live->stamp = (uint64_t*)calloc(MAX(count, 1), sizeof(uint64_t));
+	if( live->samples == NULL || live->stamp == NULL ){
+		emlive_free(live);
+		return EM_ERR_NOMEM;
+	}
+	live->unit = unit;
+	live->count = count;
+	for (i=0; i<count; i++)
+		live->samples[i] = src;
+	return EM_OK;
+}
+
+void emlive_free(struct emlive* live)
+{
+	size_t i;
+
+	if( live == NULL )
+		return;
+	for (i=0; i<live->views; i++)
+		p_emlive_free_view(live->view + i);
+	free(live->samples);
+	free(live->stamp);
+	live->samples = NULL;
+	live->stamp = NULL;
+	live->views = 0;
+	live->count = 0;
+}
+
+int emlive_add_view(struct emlive* live, const struct em_plan* plan, int flags, size_t avg_limit, size_t* view)
+{
+	struct emlive_view* v;
+	size_t n;
+
+	if( live == NULL || plan == NULL || view == NULL )
+		return EM_ERR_NULLPTR;
+	if( plan->unit_src != live->unit )
+		return EM_ERR_UNKNOWNCONV;
+	// reject plans whose emconv_plan() failed
+	if( plan->conv == NULL && plan->unit_src != plan->unit_dst )
+		return EM_ERR_UNKNOWNCONV;
+	if( live->views >= EMLIVE_MAX_VIEWS )
+		return EM_ERR_RANGE;
+
+	v = live->view + live->views;
+	memset(v, 0, sizeof(struct emlive_view));
+	v->plan = *plan;
+	v->flags = flags;
+	v->avg_limit = avg_limit;
+
+	n = MAX(live->count, 1);
+	v->values = (double*)malloc(n * sizeof(double));
+	if( flags & EMLIVE_MAXHOLD )
+		v->maxhold = (double*)malloc(n * sizeof(double));
+	if( flags & EMLIVE_MINHOLD )
+		v->minhold = (double*)malloc(n * sizeof(double));
+	if( flags & EMLIVE_AVERAGE ){
+		v->average = (double*)malloc(n * sizeof(double));
+		v->avg_count = (size_t*)calloc(n, sizeof(size_t));
+	}
+	if( v->values == NULL
+		 || ((flags & EMLIVE_MAXHOLD) && v->maxhold == NULL)
+		 || ((flags & EMLIVE_MINHOLD) && v->minhold == NULL)
+		 || ((flags & EMLIVE_AVERAGE) && (v->average == NULL || v->avg_count == NULL)) ){
+		p_emlive_free_view(v);
+		return EM_ERR_NOMEM;
+	}
+
+	// nothing converted yet
+	if( live->count > 0 )
+		p_emlive_mark(v, 0, live->count);
+	*view = live->views++;
+
+	// seed the aggregates from samples written before the view existed;
+	// the fill value of emlive_init() never counts as a measurement
+	return flags & EMLIVE_AGGREGATES ? emlive_reset(live, *view) : EM_OK;
+}
+
+int emlive_write(struct emlive* live, size_t first, const double* src, size_t count)
+{
+	size_t i;
+	int r, ret = EM_OK;
+
+	if( live == NULL || src == NULL )
+		return EM_ERR_NULLPTR;
+	if( count == 0 || first > live->count || count > live->count - first )
+		return EM_ERR_RANGE;
+
+	memcpy(live->samples + first, src, count * sizeof(double));
+	live->frame++;
+	for (i=first; i<first+count; i++)
+		live->stamp[i] = live->frame;
+	for (i=0; i<live->views; i++){
+		struct emlive_view* v = live->view + i;
+
+		if( !(v->flags & EMLIVE_AGGREGATES) ){
+			p_emlive_mark(v, first, first + count);
+			continue;
+		}
+		// aggregates must see every written value, not only the latest one
+		// left at the next refresh; convert and fold the written points now
+		r = emconv_batch(&v->plan, src, v->values + first, count);
+		if( r != EM_OK ){
+			p_emlive_mark(v, first, first + count);
+			ret = ret != EM_OK ? ret : r;
+			continue;
+		}
+		p_emlive_fold(v, first, first + count);
+	}
+	return ret;
+}
+
+int emlive_refresh(struct emlive* live, size_t view)
+{
+	struct emlive_view* v;
+	size_t s;
+	int r;
+
+	if( live == NULL )
+		return EM_ERR_NULLPTR;
+	if( view >= live->views )
+		return EM_ERR_RANGE;
+
+	v = live->view + view;
+	for (s=0; s<v->spans; s++){
+		size_t first = v->span[s].first, last = v->span[s].last;
+
+		r = emconv_batch(&v->plan, live->samples + first, v->values + first, last - first);
+		if( r != EM_OK ){
+			// keep the remaining spans dirty for the next attempt
+			memmove(v->span, v->span + s, (v->spans - s) * sizeof(struct emlive_span));
+			v->spans -= s;
+			return r;
+		}
+	}
+	v->spans = 0;
+	return EM_OK;
+}
+
+int emlive_reset(struct emlive* live, size_t view)
+{
+	struct emlive_view* v;
+	size_t i;
+	int r;
+
+	r = emlive_refresh(live, view);
+	if( r != EM_OK )
+		return r;
+
+	v = live->view + view;
+	for (i=0; i<live->count; i++){
+		// points never written hold no measurement yet
+		if( live->stamp[i] == 0 ){
+			if( v->maxhold != NULL ) v->maxhold[i] = -HUGE_VAL;
+			if( v->minhold != NULL ) v->minhold[i] = HUGE_VAL;
+			if( v->average != NULL ){
+				v->average[i] = 0.0;
+				v->avg_count[i] = 0;
+			}
+			continue;
+		}
+		if( v->maxhold != NULL ) v->maxhold[i] = v->values[i];
+		if( v->minhold != NULL ) v->minhold[i] = v->values[i];
+		if( v->average != NULL ){
+			v->average[i] = v->values[i];
+			v->avg_count[i] = 1;
+		}
+	}
+	return EM_OK;
+}
@@ -0,0 +1,86 @@
+/*
+ *  emlive.h
+ *  iemc
+ *
+ *  Live updating trace with incremental reconversion of dirty ranges.
+ *
+ */
+
+#ifndef EMLIVE_H
+#define EMLIVE_H
+
+#include "emath.h"
+
+#define EMLIVE_MAX_VIEWS  8 //! Converted views per trace
+#define EMLIVE_MAX_SPANS  8 //! Dirty spans tracked per view before merging
+
+// View aggregates
+#define EMLIVE_NONE     0 //! Converted values only
+#define EMLIVE_MAXHOLD  1 //! Keep the largest value seen per point
+#define EMLIVE_MINHOLD  2 //! Keep the smallest value seen per point
+#define EMLIVE_AVERAGE  4 //! Keep a running average per point
+#define EMLIVE_AGGREGATES (EMLIVE_MAXHOLD|EMLIVE_MINHOLD|EMLIVE_AVERAGE) //! Any aggregate
+
+//! Range [first, last) of samples written since the last refresh
+struct emlive_span
+{
+	size_t first;
+	size_t last;
+};
+
+//! Source samples converted into one unit, plus aggregates derived from them
+struct emlive_view
+{
+	struct em_plan plan;            //! Convertion from the trace unit
+	int flags;                      //! EMLIVE_* aggregates kept by this view
+	size_t avg_limit;               //! samples averaged per point, 0 for unlimited
+	double* values;                 //! converted samples
+	double* maxhold;                //! NULL unless EMLIVE_MAXHOLD
+	double* minhold;                //! NULL unless EMLIVE_MINHOLD
+	double* average;                //! NULL unless EMLIVE_AVERAGE
+	size_t* avg_count;              //! samples in the average per point
+	size_t spans;                   //! number of dirty spans
+	struct emlive_span span[EMLIVE_MAX_SPANS];
+};
+
+//! Trace of source samples with converted views
+struct emlive
+{
+	int unit;                       //! unit of the source samples
+	size_t count;                   //! number of samples
+	double* samples;                //! source samples
+	uint64_t* stamp;                //! write stamp per sample, 0 if never written
+	uint64_t frame;                 //! stamp of the latest write
+	size_t views;                   //! number of views
+	struct emlive_view view[EMLIVE_MAX_VIEWS];
+};
+
+//! Allocate a trace of count samples in unit, all set to src; the fill value
+//! is converted but never counted as a measurement by the aggregates
+EMATHSHARED_EXPORT
+int emlive_init(struct emlive* live, size_t count, int unit, double src);
+
+//! Release the trace and all its views
+EMATHSHARED_EXPORT
+void emlive_free(struct emlive* live);
+
+//! Add a view converting the trace with plan; the index of the new view is stored in view.
+//! Aggregates start from the current value of every sample written so far
+EMATHSHARED_EXPORT
+int emlive_add_view(struct emlive* live, const struct em_plan* plan, int flags, size_t avg_limit, size_t* view);
+
+//! Overwrite count samples starting at first; views keeping aggregates convert
+//! and fold them right away, all other views mark them dirty
+EMATHSHARED_EXPORT
+int emlive_write(struct emlive* live, size_t first, const double* src, size_t count);
+
+//! Reconvert the dirty spans of a view; aggregates are already up to date
+EMATHSHARED_EXPORT
+int emlive_refresh(struct emlive* live, size_t view);
+
+//! Restart the aggregates of a view from its current values; points never
+//! written are left without a measurement
+EMATHSHARED_EXPORT
+int emlive_reset(struct emlive* live, size_t view);
+
+#endif
@@ -0,0 +1,259 @@
+/*
+ *  empyr.c
+ *  iemc
+ *
+ *  Min/max decimation pyramid for zoomable display of huge traces.
+ *
+ */
+
+#include "empyr.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN(X,Y)  ( (X) < (Y) ? (X) : (Y) )
+#define MAX(X,Y)  ( (X) > (Y) ? (X) : (Y) )
+
+// how a sample of the source unit maps to linear power
+#define EMPYR_DB      0 //! decibel, power = 10^(x/10)
+#define EMPYR_LINEAR  1 //! linear power quantity, power = x
+#define EMPYR_FIELD   2 //! linear field quantity, power = x^2
+
+// classify the source unit of a trace; internal use only!
+static int p_empyr_kind(int unit)
+{
+	const struct emu_entry* emu = emu_find(unit);
+
+	if( emu != NULL && emu->db_type != EM_NOTDB )
+		return EMPYR_DB;
+	switch(unit)
+	{
+	case EMU_WATT:
+	case EMU_WM2:
+	case EMU_WCM2:
+		return EMPYR_LINEAR;
+	case EMU_VOLT:
+	case EMU_AMPERE:
+	case EMU_AM:
+	case EMU_VM:
+	case EMU_TESLA:
+	case EMU_GAUSS:
+		return EMPYR_FIELD;
+	default:
+		// application defined units tell by their quantity
+		return emu != NULL && emu->quantity == EMF_POWER ? EMPYR_LINEAR : EMPYR_FIELD;
+	}
+}
+
+static double p_empyr_power(int kind, double x)
+{
+	switch(kind)
+	{
+	case EMPYR_DB:     return db10tod(x);
+	case EMPYR_LINEAR: return x;
+	default:           return x * x;
+	}
+}
+
+static double p_empyr_unpower(int kind, double p)
+{
+	switch(kind)
+	{
+	case EMPYR_DB:     return dtodb10(p);
+	case EMPYR_LINEAR: return p;
+	default:           return sqrt(p);
+	}
+}
+
+static void p_empyr_merge(struct empyr_bucket* acc, const struct empyr_bucket* b)
+{
+	acc->min = MIN(acc->min, b->min);
+	acc->max = MAX(acc->max, b->max);
+	acc->psum += b->psum;
+}
+
+// aggregate [first, last) using full buckets of level l and finer levels for the edges
+static void p_empyr_range(const struct empyr* pyr, int kind, size_t l, size_t first, size_t last,
+								  struct empyr_bucket* acc)
+{
+	const struct empyr_level* lvl;
+	size_t fa, fb, i;
+
+	if( first >= last )
+		return;
+
+	if( l == 0 ){
+		for (i=first; i<last; i++){
+			double x = pyr->samples[i];
+			acc->min = MIN(acc->min, x);
+			acc->max = MAX(acc->max, x);
+			acc->psum += p_empyr_power(kind, x);
+		}
+		return;
+	}
+
+	lvl = pyr->level + (l - 1);
+	fa = (first + lvl->factor - 1) / lvl->factor;
+	fb = last == pyr->count ? lvl->count : last / lvl->factor;
+	if( fa >= fb ){
+		p_empyr_range(pyr, kind, l - 1, first, last, acc);
+		return;
+	}
+	for (i=fa; i<fb; i++)
+		p_empyr_merge(acc, lvl->buckets + i);
+	p_empyr_range(pyr, kind, l - 1, first, fa * lvl->factor, acc);
+	p_empyr_range(pyr, kind, l - 1, MIN(fb * lvl->factor, last), last, acc);
+}
+
+static void p_empyr_aggregate(const struct empyr* pyr, int kind, size_t first, size_t last,
+										double* min, double* max, double* mean)
+{
+	struct empyr_bucket acc;
+
+	acc.min = HUGE_VAL;
+	acc.max = -HUGE_VAL;
+	acc.psum = 0.0;
+	p_empyr_range(pyr, kind, pyr->levels, first, last, &acc);
+
+	*min = acc.min;
+	*max = acc.max;
+	*mean = p_empyr_unpower(kind, acc.psum / (double)(last - first));
+}
+
+int empyr_build(struct empyr* pyr, const double* samples, size_t count, int unit, size_t base)
+{
+	const struct empyr_bucket* prev = NULL;
+	size_t prev_count = count, factor = 1, levels = 0, i, j;
+	int kind = p_empyr_kind(unit);
+
+	if( pyr == NULL || samples == NULL )
+		return EM_ERR_NULLPTR;
+	if( base == 0 )
+		base = EMPYR_DEFAULT_BASE;
+	if( base < 2 )
+		return EM_ERR_RANGE;
+
+	memset(pyr, 0, sizeof(struct empyr));
+	pyr->unit = unit;
+	pyr->samples = samples;
+	pyr->count = count;
+	pyr->base = base;
+
+	for (i=count; i>1; i=(i+base-1)/base)
+		levels++;
+	if( levels == 0 )
+		return EM_OK;
+
+	pyr->level = (struct empyr_level*)calloc(levels, sizeof(struct empyr_level));
+	if( pyr->level == NULL )
+		return EM_ERR_NOMEM;
+
+	for (pyr->levels=0; pyr->levels<levels; pyr->levels++){
+		struct empyr_level* lvl = pyr->level + pyr->levels;
+
+		factor *= base;
+		lvl->factor = factor;
+		lvl->count = (prev_count + base - 1) / base;
+		lvl->buckets = (struct empyr_bucket*)malloc(lvl->count * sizeof(struct empyr_bucket));
+		if( lvl->buckets == NULL ){
+			empyr_free(pyr);
+			return EM_ERR_NOMEM;
+		}
+
+		for (i=0; i<lvl->count; i++){
+			struct empyr_bucket* b = lvl->buckets + i;
+			size_t last = MIN((i + 1) * base, prev_count);
+
+			b->min = HUGE_VAL;
+			b->max = -HUGE_VAL;
+			b->psum = 0.0;
+			for (j=i*base; j<last; j++){
+				if( prev != NULL ){
+					p_empyr_merge(b, prev + j);
+				} else {
+					b->min = MIN(b->min, samples[j]);
+					b->max = MAX(b->max, samples[j]);
+					b->psum += p_empyr_power(kind, samples[j]);
+				}
+			}
+		}
+		prev = lvl->buckets;
+		prev_count = lvl->count;
+	}
+	return EM_OK;
+}
+
+void empyr_free(struct empyr* pyr)
+{
+	size_t i;
+
+	if( pyr == NULL )
+		return;
+	if( pyr->level != NULL ){
+		for (i=0; i<pyr->levels; i++)
+			free(pyr->level[i].buckets);
+		free(pyr->level);
+	}
+	pyr->level = NULL;
+	pyr->levels = 0;
+}
+
+int empyr_query(const struct empyr* pyr, size_t first, size_t last, double* min, double* max, double* mean)
+{
+	if( pyr == NULL || min == NULL || max == NULL || mean == NULL )
+		return EM_ERR_NULLPTR;
+	if( first >= last || last > pyr->count )
+		return EM_ERR_RANGE;
+
+	p_empyr_aggregate(pyr, p_empyr_kind(pyr->unit), first, last, min, max, mean);
+	return EM_OK;
+}
+
+int empyr_render(const struct empyr* pyr, size_t first, size_t last, const struct em_plan* plan,
+					  double* min, double* max, double* mean, size_t pixels)
+{
+	size_t n, px;
+	int kind, r;
+
+	if( pyr == NULL || plan == NULL )
+		return EM_ERR_NULLPTR;
+	if( first >= last || last > pyr->count || pixels == 0 )
+		return EM_ERR_RANGE;
+	if( plan->unit_src != pyr->unit )
+		return EM_ERR_UNKNOWNCONV;
+
+	kind = p_empyr_kind(pyr->unit);
+	n = last - first;
+	for (px=0; px<pixels; px++){
+		size_t a = first + (size_t)((uint64_t)n * px / pixels);
+		size_t b = first + (size_t)((uint64_t)n * (px + 1) / pixels);
+		double lo, hi, avg;
+
+		// zoomed in past one sample per pixel; repeat the sample
+		if( b <= a )
+			b = a + 1;
+		p_empyr_aggregate(pyr, kind, a, b, &lo, &hi, &avg);
+		if( min != NULL )  min[px] = lo;
+		if( max != NULL )  max[px] = hi;
+		if( mean != NULL ) mean[px] = avg;
+	}
+
+	// the conversions are monotonic, so only the rendered columns need converting
+	if( min != NULL && (r = emconv_batch(plan, min, min, pixels)) != EM_OK )
+		return r;
+	if( max != NULL && (r = emconv_batch(plan, max, max, pixels)) != EM_OK )
+		return r;
+	if( mean != NULL && (r = emconv_batch(plan, mean, mean, pixels)) != EM_OK )
+		return r;
+	// keep min <= max should a conversion ever be decreasing
+	if( min != NULL && max != NULL ){
+		for (px=0; px<pixels; px++){
+			if( min[px] > max[px] ){
+				double t = min[px];
+				min[px] = max[px];
+				max[px] = t;
+			}
+		}
+	}
+	return EM_OK;
+}
@@ -0,0 +1,62 @@
+/*
+ *  empyr.h
+ *  iemc
+ *
+ *  Min/max decimation pyramid for zoomable display of huge traces.
+ *
+ */
+
+#ifndef EMPYR_H
+#define EMPYR_H
+
+#include "emath.h"
+
+//! Default number of buckets merged into one bucket of the next level
+#define EMPYR_DEFAULT_BASE 8
+
+//! Aggregate of a range of samples in the source unit of a trace
+struct empyr_bucket
+{
+	double min;   //! smallest sample
+	double max;   //! largest sample
+	double psum;  //! sum of the samples as linear power
+};
+
+//! One decimation level of a pyramid
+struct empyr_level
+{
+	size_t factor;                  //! source samples per bucket
+	size_t count;                   //! number of buckets
+	struct empyr_bucket* buckets;
+};
+
+//! Multi resolution min/max/mean power pyramid of a trace
+struct empyr
+{
+	int unit;                       //! source unit of the trace
+	const double* samples;          //! source samples, not owned; must outlive the pyramid
+	size_t count;                   //! number of source samples
+	size_t base;                    //! buckets merged per level
+	size_t levels;                  //! number of decimation levels
+	struct empyr_level* level;      //! levels ordered from fine to coarse
+};
+
+//! Build the pyramid of count samples given in unit; base 0 selects EMPYR_DEFAULT_BASE
+EMATHSHARED_EXPORT
+int empyr_build(struct empyr* pyr, const double* samples, size_t count, int unit, size_t base);
+
+//! Release all levels of a pyramid
+EMATHSHARED_EXPORT
+void empyr_free(struct empyr* pyr);
+
+//! Aggregate the samples [first, last) in the source unit; mean is the mean power in the source unit
+EMATHSHARED_EXPORT
+int empyr_query(const struct empyr* pyr, size_t first, size_t last, double* min, double* max, double* mean);
+
+//! Decimate the samples [first, last) into pixels columns converted with plan;
+//! any of min, max and mean may be NULL
+EMATHSHARED_EXPORT
+int empyr_render(const struct empyr* pyr, size_t first, size_t last, const struct em_plan* plan,
+					  double* min, double* max, double* mean, size_t pixels);
+
+#endif